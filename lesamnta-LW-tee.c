@@ -0,0 +1,242 @@
+/*
+  Tee mode for Lesamnta-LW reference C99 implementation
+
+  HashTee() forwards a stream from one file descriptor to another and
+  computes the hash value of the stream on the way.  When the input is
+  a pipe on Linux, tee(2) and splice(2) forward the data inside the
+  kernel, and the data are read only once, for hashing.  Otherwise,
+  large aligned buffers are hashed and written as they are.
+
+  Note: Lesamnta is a registered trademark of Hitachi, Ltd. in Japan.
+
+
+  Released under the MIT license
+  Copyright (C) 2015 Hidenori Kuwakado
+
+  Permission is hereby granted, free of charge, to any person
+  obtaining a copy of this software and associated documentation files
+  (the "Software"), to deal in the Software without restriction,
+  including without limitation the rights to use, copy, modify, merge,
+  publish, distribute, sublicense, and/or sell copies of the Software,
+  and to permit persons to whom the Software is furnished to do so,
+  subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be
+  included in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lesamnta-LW.h"
+
+/* Tee mode parameters */
+enum {
+    /* Buffer for hashing, a multiple of the page size */
+    BufferLengthInByte = 1 << 20,
+    BufferAlignment = 4096,
+};
+
+static int writeFull(int fd, const BitSequence *buf, size_t length)
+{
+    while (length > 0) {
+        ssize_t n = write(fd, buf, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        length -= n;
+    }
+    return 0;
+}
+
+/* Copying path: each buffer is hashed and written as it is. */
+static HashReturn teeByCopy(hashState *state, int infd, int outfd, BitSequence *buf)
+{
+    while (1) {
+        ssize_t n = read(infd, buf, BufferLengthInByte);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return FAIL;
+        } else if (n == 0) {
+            return SUCCESS;
+        }
+        Update(state, buf, (DataLength) n * 8);
+        if (writeFull(outfd, buf, n) != 0) {
+            return FAIL;
+        }
+    }
+}
+
+#ifdef __linux__
+static int isPipe(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+/* Reads length bytes unless the end of file is reached. */
+static ssize_t readFull(int fd, BitSequence *buf, size_t length)
+{
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = read(fd, buf + done, length - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        } else if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return (ssize_t) done;
+}
+
+/* Moves length bytes; *done is the number of bytes that reached outfd. */
+static int spliceFull(int infd, int outfd, size_t length, size_t *done)
+{
+    *done = 0;
+    while (*done < length) {
+        ssize_t n = splice(infd, NULL, outfd, NULL, length - *done, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        } else if (n == 0) {
+            errno = EIO;
+            return -1;
+        }
+        *done += n;
+    }
+    return 0;
+}
+
+/*
+  Splicing path: tee(2) duplicates the pages in the input pipe to the
+  output, directly if the output is a pipe and through an intermediate
+  pipe otherwise.  Then read(2) consumes the same bytes for hashing.
+  If the descriptors do not support splicing, *fallback is set, but
+  only when no data have reached outfd yet.
+*/
+static HashReturn teeBySplice(hashState *state, int infd, int outfd, BitSequence *buf, int *fallback)
+{
+    int direct = isPipe(outfd);
+    int p[2] = { -1, -1 };
+    if (!direct) {
+        if (pipe(p) != 0) {
+            return FAIL;
+        }
+        /* A larger pipe reduces the number of system calls; failure is harmless. */
+        fcntl(p[1], F_SETPIPE_SZ, BufferLengthInByte);
+    }
+
+    HashReturn ret = SUCCESS;
+    int first = 1;
+    *fallback = 0;
+    while (1) {
+        ssize_t n = tee(infd, direct ? outfd : p[1], BufferLengthInByte, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n == 0) {
+            break;
+        }
+        size_t spliced = 0;
+        if (n < 0 || (!direct && spliceFull(p[0], outfd, n, &spliced) != 0)) {
+            /* The input has not been consumed; the copying path may resend it. */
+            if (first && errno == EINVAL && spliced == 0) {
+                *fallback = 1;
+            } else {
+                ret = FAIL;
+            }
+            break;
+        }
+        ssize_t m = readFull(infd, buf, n);
+        if (m != n) {
+            /* The bytes duplicated by tee(2) must still be in the input. */
+            if (m >= 0) {
+                errno = EIO;
+            }
+            ret = FAIL;
+            break;
+        }
+        Update(state, buf, (DataLength) n * 8);
+        first = 0;
+    }
+
+    if (!direct) {
+        int err = errno;
+        close(p[0]);
+        close(p[1]);
+        errno = err;
+    }
+    return ret;
+}
+#endif  /* __linux__ */
+
+/*
+  HashTee() forwards all data read from infd to outfd and computes the
+  hash value of the data on the way.
+
+  Parameters:
+  - hashbitlen: the length in bits of the desired hash value
+  - infd: the file descriptor from which the data are read
+  - outfd: the file descriptor to which the data are written
+  - hashval: the resulting hash value of the forwarded data
+  Returns:
+  - Success value.  FAIL is returned on an I/O error, and errno is set.
+*/
+HashReturn HashTee(int hashbitlen, int infd, int outfd, BitSequence *hashval)
+{
+    hashState state;
+    HashReturn ret = Init(&state, hashbitlen);
+    if (ret != SUCCESS) {
+        return ret;
+    }
+    void *buf = NULL;
+    if (posix_memalign(&buf, BufferAlignment, BufferLengthInByte) != 0) {
+        errno = ENOMEM;
+        return FAIL;
+    }
+
+    int fallback = 1;
+#ifdef __linux__
+    if (isPipe(infd)) {
+        ret = teeBySplice(&state, infd, outfd, buf, &fallback);
+    }
+#endif
+    if (ret == SUCCESS && fallback) {
+        ret = teeByCopy(&state, infd, outfd, buf);
+    }
+    int err = errno;
+    free(buf);
+    errno = err;
+    if (ret != SUCCESS) {
+        return ret;
+    }
+
+    return Final(&state, hashval);
+}
+
+/* end of file */
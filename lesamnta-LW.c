@@ -59,6 +59,8 @@ enum {
     BlockLengthInBit  = 256,
     BlockLengthInByte = BlockLengthInBit / 8,
     BlockLengthInWord = BlockLengthInBit / 32,
+    /* Interleaved compression */
+    MaxLanes = 4,
 };
 
 /* Initial values
@@ -244,15 +246,6 @@ static void blockCipher(uint32_t *ciphertext, const uint32_t *key, const uint32_
 
 
 /* ***************************************************************** */
-/* SHA-3 API: Internal state */
-typedef struct {
-    int hashbitlen;
-	uint32_t messageLength[2];
-	uint32_t remainingLength;
-	uint32_t message[MessageBlockLengthInWord];
-	uint32_t hash[HashLengthInWord];
-} hashState;
-
 /*
   SHA-3 API: Init() initializes a hashState with the intended hash
   length of this particular instantiation.  Additionally, any data
@@ -265,7 +258,7 @@ typedef struct {
   Returns:
   - Success value.
 */
-static HashReturn Init(hashState *state, int hashbitlen)
+HashReturn Init(hashState *state, int hashbitlen)
 {
     /* The hash length is 256. */
     if (hashbitlen != HashLengthInBit) {
@@ -313,11 +306,71 @@ static void compressionFunction(uint32_t *hash, const uint32_t *message)
     memcpy(hash, ciphertext, sizeof(ciphertext));
 }
 
+/* Interleaved compression function
+   Each round depends on the previous one through function G, so a
+   single stream leaves most execution units idle.  Here independent
+   lanes are advanced in lockstep within one round loop, and round keys
+   are generated on the fly. */
+static inline void compressionFunctionInterleaved(uint32_t *const *hash, const uint32_t *const *message, int lanes)
+{
+    uint32_t k[MaxLanes][KeyLengthInWord];
+    uint32_t block[MaxLanes][BlockLengthInWord];
+    for (int j = 0; j < lanes; ++j) {
+        memcpy(k[j], hash[j], sizeof(k[j]));
+        memcpy(block[j], message[j], sizeof(block[j]) / 2);
+        memcpy(block[j] + 4, hash[j] + 4, sizeof(block[j]) / 2);
+    }
+
+    for (int round = 0; round < NumberOfRounds; ++round) {
+        for (int j = 0; j < lanes; ++j) {
+            /* Key schedule */
+            uint32_t roundKey = k[j][0];
+            uint32_t key = C[round] ^ k[j][2];
+            functionQ(&key);
+            key ^= k[j][3];
+            k[j][3] = k[j][2];
+            k[j][2] = k[j][1];
+            k[j][1] = k[j][0];
+            k[j][0] = key;
+
+            /* Message mixing */
+            uint32_t buf[2] = { 0x00 };
+            functionG(buf, roundKey, block[j] + 4);
+            buf[0] ^= block[j][6];
+            buf[1] ^= block[j][7];
+            block[j][7] = block[j][5];
+            block[j][6] = block[j][4];
+            block[j][5] = block[j][3];
+            block[j][4] = block[j][2];
+            block[j][3] = block[j][1];
+            block[j][2] = block[j][0];
+            block[j][1] = buf[1];
+            block[j][0] = buf[0];
+        }
+    }
+
+    for (int j = 0; j < lanes; ++j) {
+        memcpy(hash[j], block[j], sizeof(block[j]));
+    }
+}
+
+static void compressionFunction2(uint32_t *const *hash, const uint32_t *const *message)
+{
+    compressionFunctionInterleaved(hash, message, 2);
+}
+
+static void compressionFunction4(uint32_t *const *hash, const uint32_t *const *message)
+{
+    compressionFunctionInterleaved(hash, message, 4);
+}
+
 /*
   SHA-3 API: Update() processes data using the compression function.
   Whatever integral amount of data the Update() routine can process
   through the compression function is handled. Any remaining data must
-  be stored for future processing.
+  be stored for future processing.  Update() may be called repeatedly;
+  the data length of every call except the last must be a multiple of 8.
+  FAIL is returned if Update() is called after such a last call.
 
   Parameters:
   - state: a structure that holds the hashState information
@@ -326,11 +379,36 @@ static void compressionFunction(uint32_t *hash, const uint32_t *message)
   Returns:
   - Success value.
 */
-static HashReturn Update(hashState *state, const BitSequence *data, DataLength databitlen)
+HashReturn Update(hashState *state, const BitSequence *data, DataLength databitlen)
 {
-    /* messageLength[0] is the most significant word． */
-    state->messageLength[0] = (uint32_t)(databitlen >> 32);
-    state->messageLength[1] = (uint32_t)databitlen;
+    /* Only the last call may give a length that is not a multiple of 8. */
+    if (state->remainingLength % 8 != 0) {
+        return FAIL;
+    }
+
+    /* messageLength[0] is the most significant word. */
+    uint32_t lower = state->messageLength[1] + (uint32_t)databitlen;
+    state->messageLength[0] += (uint32_t)(databitlen >> 32) + (lower < state->messageLength[1] ? 1 : 0);
+    state->messageLength[1] = lower;
+
+    /* Fill the block left by the previous call.  Since the previous
+       data length must be a multiple of 8, data are appended bytewise. */
+    while (state->remainingLength != 0 && databitlen != 0) {
+        uint32_t i = state->remainingLength / 8;
+        uint32_t bitlen = databitlen < 8 ? (uint32_t)databitlen : 8;
+        state->message[i / 4] |= ((uint32_t) data[0]) << (24 - 8 * (i % 4));
+        state->remainingLength += bitlen;
+        data += 1;
+        databitlen -= bitlen;
+        if (state->remainingLength == MessageBlockLengthInBit) {
+            compressionFunction(state->hash, state->message);
+            state->remainingLength = 0;
+            memset(state->message, 0x00, MessageBlockLengthInByte);
+        }
+    }
+    if (databitlen == 0) {
+        return SUCCESS;
+    }
 
     /* Apply the compression function. */
     while (databitlen >= MessageBlockLengthInBit) {
@@ -382,7 +460,7 @@ static void toBitSequence256(BitSequence *hashval, const uint32_t *hash)
   Returns:
   - Success value.
 */
-static HashReturn Final(hashState *state, BitSequence *hashval)
+HashReturn Final(hashState *state, BitSequence *hashval)
 {
     /* Is the message length a multiple of the block length? */
     if (state->remainingLength == 0) {
@@ -444,4 +522,150 @@ HashReturn Hash(int hashbitlen, const BitSequence *data,
     return SUCCESS;
 }
 
+/* ***************************************************************** */
+/* Multi-stream hashing: Internal state of a lane */
+enum {
+    /* Full and partial message blocks remain. */
+    LaneMessage = 0,
+    /* Only the block with the message length remains. */
+    LaneLength = 1,
+    /* No block remains. */
+    LaneDone = 2,
+};
+
+typedef struct {
+    const BitSequence *data;
+    DataLength remainingLength;
+    uint32_t messageLength[2];
+    int stage;
+    uint32_t message[MessageBlockLengthInWord];
+    uint32_t hash[HashLengthInWord];
+} laneState;
+
+static void initLane(laneState *lane, const BitSequence *data, DataLength databitlen)
+{
+    lane->data = data;
+    lane->remainingLength = databitlen;
+    /* messageLength[0] is the most significant word. */
+    lane->messageLength[0] = (uint32_t)(databitlen >> 32);
+    lane->messageLength[1] = (uint32_t)databitlen;
+    lane->stage = LaneMessage;
+    memset(lane->message, 0x00, MessageBlockLengthInByte);
+    memcpy(lane->hash, initialValue, HashLengthInByte);
+}
+
+/*
+  Sets the next message block of a lane, including the padding and
+  the length block that Final() would produce.  Returns 0 if the lane
+  has no block left.
+*/
+static int nextMessageBlock(laneState *lane)
+{
+    if (lane->stage == LaneMessage) {
+        if (lane->remainingLength >= MessageBlockLengthInBit) {
+            setMessage(lane->message, lane->data);
+            lane->data += MessageBlockLengthInByte;
+            lane->remainingLength -= MessageBlockLengthInBit;
+            return 1;
+        }
+        /* Is the message length a multiple of the block length? */
+        if (lane->remainingLength == 0) {
+            lane->message[0] = 0x80000000U;
+            lane->message[1] = 0x00000000U;
+            lane->message[2] = lane->messageLength[0];
+            lane->message[3] = lane->messageLength[1];
+            lane->stage = LaneDone;
+        } else {
+            setRemainingMessage(lane->message, (uint32_t)lane->remainingLength, lane->data);
+            paddingMessage(lane->message, (uint32_t)lane->remainingLength);
+            lane->remainingLength = 0;
+            lane->stage = LaneLength;
+        }
+        return 1;
+    } else if (lane->stage == LaneLength) {
+        lane->message[0] = 0x00000000U;
+        lane->message[1] = 0x00000000U;
+        lane->message[2] = lane->messageLength[0];
+        lane->message[3] = lane->messageLength[1];
+        lane->stage = LaneDone;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+  HashMulti() computes the hash values of several independent messages
+  at once.  Up to four messages are compressed in lockstep by the
+  interleaved compression function; whenever a message is exhausted,
+  its lane is refilled with the next message, so messages of mixed
+  lengths keep the lanes busy.  The results are the same as those of
+  calling Hash() for each message.
+
+  Parameters:
+  - hashbitlen: the length in bits of the desired hash values
+  - count: the number of messages
+  - data: the input data to be hashed, one per message
+  - databitlen: the lengths, in bits, of the data to be hashed
+  - hashval: the storage for the resulting hash values, one per message
+  Returns:
+  - Success value.
+*/
+HashReturn HashMulti(int hashbitlen, int count, const BitSequence *const *data,
+                     const DataLength *databitlen, BitSequence *const *hashval)
+{
+    if (hashbitlen != HashLengthInBit) {
+        return BAD_HASHBITLEN;
+    }
+    if (count < 0) {
+        return FAIL;
+    }
+
+    laneState lanes[MaxLanes];
+    /* owner[j] is the index of the message in lane j, or -1 if idle. */
+    int owner[MaxLanes] = { -1, -1, -1, -1 };
+    int next = 0;
+    while (1) {
+        /* Refill idle lanes and collect the lanes having a block. */
+        uint32_t *hash[MaxLanes] = { NULL };
+        const uint32_t *message[MaxLanes] = { NULL };
+        int ready = 0;
+        for (int j = 0; j < MaxLanes; ++j) {
+            while (owner[j] >= 0 || next < count) {
+                if (owner[j] < 0) {
+                    initLane(&lanes[j], data[next], databitlen[next]);
+                    owner[j] = next;
+                    ++next;
+                }
+                if (nextMessageBlock(&lanes[j])) {
+                    hash[ready] = lanes[j].hash;
+                    message[ready] = lanes[j].message;
+                    ++ready;
+                    break;
+                }
+                toBitSequence256(hashval[owner[j]], lanes[j].hash);
+                owner[j] = -1;
+            }
+        }
+        if (ready == 0) {
+            break;
+        }
+
+        /* Apply the widest compression function available. */
+        int j = 0;
+        if (ready - j >= 4) {
+            compressionFunction4(hash + j, message + j);
+            j += 4;
+        }
+        if (ready - j >= 2) {
+            compressionFunction2(hash + j, message + j);
+            j += 2;
+        }
+        if (ready - j >= 1) {
+            compressionFunction(hash[j], message[j]);
+        }
+    }
+
+    return SUCCESS;
+}
+
 /* end of file */
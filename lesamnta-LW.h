@@ -59,6 +59,59 @@ typedef enum {
 	BAD_HASHBITLEN = 2,
 } HashReturn;
 
+/* SHA-3 API: Internal state */
+typedef struct {
+    int hashbitlen;
+	uint32_t messageLength[2];
+	uint32_t remainingLength;
+	uint32_t message[128 / 32];
+	uint32_t hash[LESAMNTALW_HASH_BITLENGTH / 32];
+} hashState;
+
+/*
+  SHA-3 API: Init() initializes a hashState with the intended hash
+  length of this particular instantiation.  Additionally, any data
+  independent setup is performed.
+
+  Parameters:
+  - state: a structure that holds the hashState information
+  - hashbitlen: an integer value that indicates the length of the hash
+  output in bits.
+  Returns:
+  - Success value.
+*/
+HashReturn Init(hashState *state, int hashbitlen);
+
+/*
+  SHA-3 API: Update() processes data using the compression function.
+  Whatever integral amount of data the Update() routine can process
+  through the compression function is handled. Any remaining data must
+  be stored for future processing.  Update() may be called repeatedly;
+  the data length of every call except the last must be a multiple of 8.
+  FAIL is returned if Update() is called after such a last call.
+
+  Parameters:
+  - state: a structure that holds the hashState information
+  - data: the input data to be hashed
+  - databitlen: the length, in bits, of the input data to be hashed
+  Returns:
+  - Success value.
+*/
+HashReturn Update(hashState *state, const BitSequence *data, DataLength databitlen);
+
+/*
+  SHA-3 API: Final() processes any remaining partial block of the
+  input data and performs any output filtering that may be needed to
+  produce the final hash value.
+
+  Parameters:
+  - state: a structure that holds the hashState information
+  - hashval: the storage for the final (output) hash value to be returned
+  Returns:
+  - Success value.
+*/
+HashReturn Final(hashState *state, BitSequence *hashval);
+
 /*
   SHA-3 API: Hash() provides a method to perform all-at-once
   processing of the input data and returns the resulting hash
@@ -80,6 +133,43 @@ typedef enum {
 HashReturn Hash(int hashbitlen, const BitSequence *data,
                 DataLength databitlen, BitSequence *hashval);
 
+/*
+  HashMulti() computes the hash values of several independent messages
+  at once.  The messages are hashed in interleaved lanes so that the
+  round computations of different messages overlap.  Messages may have
+  different lengths.  The results are the same as those of calling
+  Hash() for each message.
+
+  Parameters:
+  - hashbitlen: the length in bits of the desired hash values
+  - count: the number of messages
+  - data: the input data to be hashed, one per message
+  - databitlen: the lengths, in bits, of the data to be hashed
+  - hashval: the storage for the resulting hash values, one per message
+  Returns:
+  - Success value.
+*/
+HashReturn HashMulti(int hashbitlen, int count, const BitSequence *const *data,
+                     const DataLength *databitlen, BitSequence *const *hashval);
+
+/*
+  HashTee() forwards all data read from infd to outfd and computes the
+  hash value of the data on the way.  On Linux, when both descriptors
+  are pipes, or infd is a pipe and outfd accepts splice(2), the data
+  are forwarded without copying through user space, and only the copy
+  for hashing is read.  Otherwise, large aligned buffers are used.  The function
+  returns at the end of file of infd.
+
+  Parameters:
+  - hashbitlen: the length in bits of the desired hash value
+  - infd: the file descriptor from which the data are read
+  - outfd: the file descriptor to which the data are written
+  - hashval: the resulting hash value of the forwarded data
+  Returns:
+  - Success value.  FAIL is returned on an I/O error, and errno is set.
+*/
+HashReturn HashTee(int hashbitlen, int infd, int outfd, BitSequence *hashval);
+
 
 #endif  /* ___LESAMNTALW_H */
 
@@ -29,6 +29,7 @@
 
 #define _GNU_SOURCE
 
+#include <errno.h>
 #include <getopt.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -42,7 +43,8 @@
 
 static void showUsage(const char *programName)
 {
-    fprintf(stderr, "%s [--help] [--testVector] file\n", programName);
+    fprintf(stderr, "%s [--help] [--testVector] file...\n", programName);
+    fprintf(stderr, "%s --tee[=digestFile] < input > output\n", programName);
 }
 
 
@@ -89,16 +91,88 @@ static void showTestVector(void)
             printf("%02x", hashval[i]);
         }
         printf("\n");
+
+        /* Incremental Update() with chunks that do not fill a block */
+        BitSequence incremental[LESAMNTALW_HASH_BITLENGTH / 8];
+        hashState state;
+        Init(&state, LESAMNTALW_HASH_BITLENGTH);
+        for (int i = 0; i < NELMS(data); i += 5) {
+            int bytelen = NELMS(data) - i < 5 ? NELMS(data) - i : 5;
+            Update(&state, data + i, (DataLength)bytelen * 8);
+        }
+        Final(&state, incremental);
+        if (memcmp(hashval, incremental, sizeof(hashval)) != 0) {
+            fprintf(stderr, "Incremental Update() gives a different hash value\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+static BitSequence *readFile(const char *fileName, DataLength *bytelen)
+{
+    FILE *fp = fopen(fileName, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Not found: %s\n", fileName);
+        exit(EXIT_FAILURE);
+    }
+    BitSequence *data = malloc(BUFSIZ);
+    if (data == NULL) {
+        fprintf(stderr, "Not enough memory\n");
+        exit(EXIT_FAILURE);
+    }
+    *bytelen = 0;
+    int c;
+    while ((c = fgetc(fp)) != EOF) {
+        data[*bytelen] = (BitSequence)c;
+        ++*bytelen;
+        if (*bytelen % BUFSIZ == 0) {
+            BitSequence *tmp = realloc(data, *bytelen + BUFSIZ);
+            if (tmp == NULL) {
+                fprintf(stderr, "Not enough memory\n");
+                exit(EXIT_FAILURE);
+            } else {
+                data = tmp;
+            }
+        }
+    }
+    fclose(fp);
+
+    return data;
+}
+
+
+static void runTee(FILE *digest)
+{
+    /* The standard input is forwarded to the standard output. */
+    BitSequence hashval[LESAMNTALW_HASH_BITLENGTH / 8];
+    if (HashTee(LESAMNTALW_HASH_BITLENGTH, STDIN_FILENO, STDOUT_FILENO, hashval) != SUCCESS) {
+        fprintf(stderr, "Failed to forward: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    /* The hash value goes to the standard error or the digest file. */
+    fprintf(digest, "hashval: ");
+    for (int i = 0; i < LESAMNTALW_HASH_BITLENGTH / 8; ++i) {
+        fprintf(digest, "%02x", hashval[i]);
+    }
+    fprintf(digest, "\n");
+    if (fflush(digest) != 0 || ferror(digest)) {
+        fprintf(stderr, "Cannot write the hash value\n");
+        exit(EXIT_FAILURE);
     }
 }
 
 
 int main(int argc, char *argv[])
 {
+    int teeMode = 0;
+    const char *digestFile = NULL;
     while (1) {
         static struct option long_options[] = {
             {"help", no_argument, NULL, 'h'},
             {"testVector", no_argument, NULL, 't'},
+            {"tee", optional_argument, NULL, 'T'},
             {0, 0, 0, 0}
         };
         int c = getopt_long(argc, argv, "", long_options, NULL);
@@ -110,51 +184,83 @@ int main(int argc, char *argv[])
         } else if (c == 't') {
             showTestVector();
             exit(EXIT_SUCCESS);
+        } else if (c == 'T') {
+            teeMode = 1;
+            digestFile = optarg;
         } else {
             fprintf(stderr, "Not supported option: %x\n", c);
             exit(EXIT_FAILURE);
         }
     }
 
-    /* A message is read from the file. */
-    FILE *fp = fopen(argv[optind], "r");
-    if (fp == NULL) {
-        fprintf(stderr, "Not found: %s\n", argv[optind]);
+    if (teeMode) {
+        /* The tee mode takes no file; the digest file is given as --tee=file. */
+        if (optind < argc) {
+            showUsage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        /* The digest file is opened first so that the stream is not lost. */
+        FILE *digest = stderr;
+        if (digestFile != NULL) {
+            digest = fopen(digestFile, "w");
+            if (digest == NULL) {
+                fprintf(stderr, "Cannot open: %s\n", digestFile);
+                exit(EXIT_FAILURE);
+            }
+        }
+        runTee(digest);
+        if (digest != stderr && fclose(digest) != 0) {
+            fprintf(stderr, "Cannot write: %s\n", digestFile);
+            exit(EXIT_FAILURE);
+        }
+        exit(EXIT_SUCCESS);
+    }
+
+    if (optind >= argc) {
+        showUsage(argv[0]);
         exit(EXIT_FAILURE);
     }
-    BitSequence *data = malloc(BUFSIZ);
-    if (data == NULL) {
+
+    /* Messages are read from the files. */
+    int count = argc - optind;
+    BitSequence **data = malloc(count * sizeof(data[0]));
+    DataLength *databitlen = malloc(count * sizeof(databitlen[0]));
+    BitSequence (*hashval)[LESAMNTALW_HASH_BITLENGTH / 8] = malloc(count * sizeof(hashval[0]));
+    BitSequence **hashvalp = malloc(count * sizeof(hashvalp[0]));
+    if (data == NULL || databitlen == NULL || hashval == NULL || hashvalp == NULL) {
         fprintf(stderr, "Not enough memory\n");
         exit(EXIT_FAILURE);
     }
-    DataLength bytelen = 0;
-    int c;
-    while ((c = fgetc(fp)) != EOF) {
-        data[bytelen] = (BitSequence)c;
-        ++bytelen;
-        if (bytelen % BUFSIZ == 0) {
-            BitSequence *tmp = realloc(data, bytelen + BUFSIZ);
-            if (tmp == NULL) {
-                fprintf(stderr, "Not enough memory\n");
-                exit(EXIT_FAILURE);
-            } else {
-                data = tmp;
-            }
-        }
+    for (int i = 0; i < count; ++i) {
+        DataLength bytelen = 0;
+        data[i] = readFile(argv[optind + i], &bytelen);
+        databitlen[i] = bytelen * 8;
+        hashvalp[i] = hashval[i];
     }
-    DataLength databitlen = bytelen * 8;
-    BitSequence hashval[LESAMNTALW_HASH_BITLENGTH / 8];
-    Hash(LESAMNTALW_HASH_BITLENGTH, data, databitlen, hashval);
-    printf("message: ");
-    for (int i = 0; i < bytelen; ++i) {
-            printf("%02x", data[i]);
+
+    /* Several files are hashed at once by the interleaved lanes. */
+    if (count == 1) {
+        Hash(LESAMNTALW_HASH_BITLENGTH, data[0], databitlen[0], hashval[0]);
+    } else {
+        HashMulti(LESAMNTALW_HASH_BITLENGTH, count,
+                  (const BitSequence *const *)data, databitlen, hashvalp);
     }
-    printf("\n");
-    printf("hashval: ");
-    for (int i = 0; i < LESAMNTALW_HASH_BITLENGTH / 8; ++i) {
-        printf("%02x", hashval[i]);
+    for (int i = 0; i < count; ++i) {
+        printf("message: ");
+        for (DataLength j = 0; j < databitlen[i] / 8; ++j) {
+            printf("%02x", data[i][j]);
+        }
+        printf("\n");
+        printf("hashval: ");
+        for (int j = 0; j < LESAMNTALW_HASH_BITLENGTH / 8; ++j) {
+            printf("%02x", hashval[i][j]);
+        }
+        printf("\n");
+        free(data[i]);
     }
-    printf("\n");
+    free(hashvalp);
+    free(hashval);
+    free(databitlen);
     free(data);
 
     return 0;